@@ -0,0 +1,162 @@
+#include <algorithm>
+
+#include "acquisition_scheduler.h"
+
+
+// HX711 datasheet figures, the supply is the Raspberry Pi 3.3 V rail
+const double activeCurrent = 1.5; // mA
+const double powerDownCurrent = 0.001; // mA
+const double supplyVoltage = 3.3; // V
+
+AcquisitionScheduler::AcquisitionScheduler(const Seconds interval, const unsigned int settlingFrames,
+                                           const unsigned int burstFrames, const double sampleRate,
+                                           const Seconds margin)
+{
+    m_interval = interval.count() > 0 ? interval : Seconds(1);
+    m_settlingFrames = settlingFrames;
+    m_burstFrames = burstFrames ? burstFrames : 1;
+    m_margin = margin;
+
+    m_state = Sleeping;
+    m_frames = 0;
+
+    // until the first burst is measured the latency is the nominal conversion time
+    m_latencyEstimate = Seconds((m_settlingFrames + m_burstFrames) / (sampleRate > 0 ? sampleRate : 10));
+    m_lastLatency = m_maxLatency = m_awake = Seconds(0);
+
+    // a chip which does not deliver the burst in three nominal conversion times plus a second is given up
+    m_timeout = m_latencyEstimate * 3 + Seconds(1);
+
+    m_bursts = m_missed = m_skipped = m_timeouts = 0;
+}
+
+void AcquisitionScheduler::start(const Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_state = Sleeping;
+    m_frames = 0;
+    m_started = m_wake = now;
+    m_deadline = now + std::chrono::duration_cast<Clock::duration>(m_latencyEstimate + m_margin);
+    m_awake = Seconds(0);
+    m_bursts = m_missed = m_skipped = m_timeouts = 0;
+}
+
+bool AcquisitionScheduler::wakeDue(const Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_state != Sleeping || now < m_wake)
+        return false;
+
+    m_state = Settling;
+    m_frames = 0;
+    m_woken = now;
+
+    return true;
+}
+
+AcquisitionScheduler::Frame AcquisitionScheduler::frame(const Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_state == Sleeping || m_state == Finishing)
+        return Discard;
+
+    ++m_frames;
+
+    if (m_state == Settling) {
+        if (m_frames <= m_settlingFrames) {
+            if (m_frames == m_settlingFrames)
+                m_state = Measuring;
+            return Discard;
+        }
+
+        m_state = Measuring;
+    }
+
+    if (m_frames - m_settlingFrames < m_burstFrames)
+        return Measure;
+
+    const Seconds latency = now - m_woken;
+
+    m_lastLatency = latency;
+    m_maxLatency = std::max(m_maxLatency, latency);
+
+    // fast attack, slow decay: a late burst moves the next wake-up earlier at once
+    m_latencyEstimate = latency > m_latencyEstimate ? latency : m_latencyEstimate * 0.75 + latency * 0.25;
+
+    ++m_bursts;
+    if (now > m_deadline)
+        ++m_missed;
+
+    m_state = Finishing;
+
+    return Last;
+}
+
+void AcquisitionScheduler::finish(const Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_state != Finishing)
+        return;
+
+    m_awake += now - m_woken;
+    m_state = Sleeping;
+    planNextWake(now);
+}
+
+bool AcquisitionScheduler::timedOut(const Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if ((m_state != Settling && m_state != Measuring) || now - m_woken < m_timeout)
+        return false;
+
+    m_awake += now - m_woken;
+    ++m_timeouts;
+    m_state = Sleeping;
+    planNextWake(now);
+
+    return true;
+}
+
+double AcquisitionScheduler::dutyCycle(const Clock::time_point now) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Seconds elapsed = now - m_started;
+    Seconds awake = m_awake;
+
+    if (m_state != Sleeping)
+        awake += now - m_woken;
+
+    return elapsed.count() > 0 ? std::min(awake / elapsed, 1.0) : 1;
+}
+
+double AcquisitionScheduler::averageCurrent(const Clock::time_point now) const
+{
+    const double duty = dutyCycle(now);
+
+    return duty * activeCurrent + (1 - duty) * powerDownCurrent;
+}
+
+double AcquisitionScheduler::energyPerResult(const Clock::time_point now) const
+{
+    return averageCurrent(now) * supplyVoltage * m_interval.count();
+}
+
+// Deadlines stay on the fixed cadence. A deadline which has already passed is skipped, otherwise the chip wakes
+// the estimated latency plus the margin ahead of it (at once if that moment is gone).
+void AcquisitionScheduler::planNextWake(const Clock::time_point now)
+{
+    const auto interval = std::chrono::duration_cast<Clock::duration>(m_interval);
+
+    m_deadline += interval;
+    while (m_deadline <= now) {
+        m_deadline += interval;
+        ++m_skipped;
+    }
+
+    m_wake = m_deadline - std::chrono::duration_cast<Clock::duration>(m_latencyEstimate + m_margin);
+}
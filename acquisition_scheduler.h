@@ -0,0 +1,94 @@
+#ifndef ACQUISITION_SCHEDULER_H
+#define ACQUISITION_SCHEDULER_H
+
+#include <chrono>
+#include <mutex>
+
+
+// Duty-cycled acquisition: the chip sleeps between bursts, a burst discards the settling frames, passes the rest
+// through the filters and ends with one result. Every result has a deadline on a fixed cadence, the wake-up is
+// scheduled ahead of it by the measured wake-to-result latency. The scheduler only tracks time and frames, so it can
+// be driven by the driver or by a simulated chip.
+class AcquisitionScheduler {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::chrono::duration<double> Seconds;
+
+    enum State {
+        Sleeping = 0,
+        Settling = 1,
+        Measuring = 2,
+        Finishing = 3 // the result is being emitted, the chip is not powered down yet
+    };
+
+    enum Frame {
+        Discard = 0, // settling or unexpected frame, must not reach the filters
+        Measure = 1, // goes through the filters
+        Last = 2 // goes through the filters, emits the result, then the chip is powered down and finish() called
+    };
+
+private:
+    Seconds m_interval;
+    unsigned int m_settlingFrames;
+    unsigned int m_burstFrames;
+    Seconds m_margin;
+    Seconds m_timeout;
+
+    State m_state;
+    unsigned int m_frames;
+
+    Clock::time_point m_started;
+    Clock::time_point m_deadline;
+    Clock::time_point m_wake;
+    Clock::time_point m_woken;
+
+    Seconds m_latencyEstimate;
+    Seconds m_lastLatency;
+    Seconds m_maxLatency;
+    Seconds m_awake;
+
+    unsigned int m_bursts;
+    unsigned int m_missed;
+    unsigned int m_skipped;
+    unsigned int m_timeouts;
+
+    mutable std::mutex m_mutex;
+
+public:
+    AcquisitionScheduler(const Seconds interval, const unsigned int settlingFrames, const unsigned int burstFrames,
+                         const double sampleRate, const Seconds margin);
+
+    void start(const Clock::time_point now);
+
+    // Returns true once when the chip must be powered up.
+    bool wakeDue(const Clock::time_point now);
+
+    // Classifies the next frame, after a Last frame no more frames are taken until finish().
+    Frame frame(const Clock::time_point now);
+
+    // Puts the scheduler to sleep, must be called once the chip has been powered down after a Last frame.
+    void finish(const Clock::time_point now);
+
+    // Returns true once when a burst has been waiting for frames too long, the chip must be powered down then.
+    bool timedOut(const Clock::time_point now);
+
+    inline State state() const { std::lock_guard<std::mutex> lock(m_mutex); return m_state; }
+    inline unsigned int bursts() const { std::lock_guard<std::mutex> lock(m_mutex); return m_bursts; }
+    inline unsigned int missed() const { std::lock_guard<std::mutex> lock(m_mutex); return m_missed; }
+    inline unsigned int skipped() const { std::lock_guard<std::mutex> lock(m_mutex); return m_skipped; }
+    inline unsigned int timeouts() const { std::lock_guard<std::mutex> lock(m_mutex); return m_timeouts; }
+    inline Seconds lastLatency() const { std::lock_guard<std::mutex> lock(m_mutex); return m_lastLatency; }
+    inline Seconds maxLatency() const { std::lock_guard<std::mutex> lock(m_mutex); return m_maxLatency; }
+
+    // Share of time the chip has been powered up since start().
+    double dutyCycle(const Clock::time_point now) const;
+
+    // Estimated average supply current (mA) and energy per result (mJ) at the current duty cycle.
+    double averageCurrent(const Clock::time_point now) const;
+    double energyPerResult(const Clock::time_point now) const;
+
+protected:
+    void planNextWake(const Clock::time_point now);
+};
+
+#endif // ACQUISITION_SCHEDULER_H
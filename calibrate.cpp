@@ -0,0 +1,122 @@
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "calibration.h"
+#include "double_to_string.h"
+#include "config.h"
+
+
+struct Dataset {
+    const char *filename;
+    std::shared_ptr<Calibration> calibration;
+    bool loaded;
+    bool fitted;
+};
+
+std::string help()
+{
+    return "\n\nhx711_calibrate <threads> <window> <threshold> <method> <huber_delta> <temperature_span>\n"
+           "\t<recording> [<recording> ...]\n\n"
+           "\tthreads - count of worker threads (0 - count of cores)\n"
+           "\twindow - count of consecutive samples which must be stable to form a plateau\n"
+           "\tthreshold - maximal standard deviation of a stable window (raw units)\n"
+           "\tmethod - 0 - Huber regression, 1 - RANSAC\n"
+           "\thuber delta - residual threshold of the robust fit (output units)\n"
+           "\ttemperature span - minimal temperature range of a recording to fit the temperature factor\n"
+           "\t\t(thousandths of degrees Celsius)\n"
+           "\trecording - recorded session, one \"<temperature> <raw> <reference>\" triple per line\n\n"
+           "For each recording writes \"<recording> <alignment_string> <temperature_factor> <base_temperature>\"\n"
+           "to stdout (temperature factor is ascii-coded), residual and throughput reports go to stderr.\n";
+}
+
+void worker(std::vector<Dataset> *datasets, std::atomic_size_t *next)
+{
+    for (std::size_t i = (*next)++; i < datasets->size(); i = (*next)++) {
+        Dataset &dataset = (*datasets)[i];
+
+        dataset.loaded = dataset.calibration->load(dataset.filename);
+        dataset.fitted = dataset.loaded && dataset.calibration->fit();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::cerr << "HX711 calibration tool, version " << applicationVersion << '\n' << std::endl;
+
+    if (argc < 8) {
+        std::cerr << "No enough parameters" << help() << std::endl;
+        return 1;
+    }
+
+    unsigned int threads = atoi(argv[1]);
+    const int window = atoi(argv[2]);
+    const double threshold = atof(argv[3]);
+    const auto method = static_cast<Calibration::Method>(atoi(argv[4]) ? 1 : 0);
+    const double huberDelta = atof(argv[5]);
+    const double temperatureSpan = atof(argv[6]);
+
+    if (window < 1 || threshold < 0 || huberDelta <= 0 || temperatureSpan < 0) {
+        std::cerr << "Invalid parameters" << help() << std::endl;
+        return 1;
+    }
+
+    std::vector<Dataset> datasets;
+
+    for (int i = 7; i < argc; ++i)
+        datasets.push_back({ argv[i], std::make_shared<Calibration>(window, threshold, method, huberDelta,
+                                                                    temperatureSpan), false, false });
+
+    if (!threads)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (threads > datasets.size())
+        threads = datasets.size();
+
+    const auto started = std::chrono::steady_clock::now();
+    std::atomic_size_t next(0);
+    std::vector<std::thread> pool;
+
+    for (unsigned int i = 0; i < threads; ++i)
+        pool.emplace_back(worker, &datasets, &next);
+
+    for (auto &el : pool)
+        el.join();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    std::size_t samples = 0, failed = 0;
+
+    for (const auto &el : datasets) {
+        const Calibration &calibration = *el.calibration;
+
+        samples += calibration.samples().size();
+
+        if (!el.fitted) {
+            ++failed;
+            std::cerr << el.filename << ": " << (el.loaded ? "not enough stable plateaus" : "could not read recording") <<
+                      std::endl;
+            continue;
+        }
+
+        std::cout << el.filename << ' ' << calibration.alignmentString() << ' ' <<
+                  doubleToString(calibration.temperatureFactor()) << ' ' << calibration.baseTemperature() << std::endl;
+
+        std::cerr << el.filename << ":: samples: " << calibration.samples().size() <<
+                  ", plateaus: " << calibration.plateaus().size() << ", outliers: " << calibration.outliers() <<
+                  ", RMS: " << calibration.rms() << ", max: " << calibration.maxResidual() << '\n' <<
+                  "\tk: " << calibration.k() << ", b: " << calibration.b() <<
+                  ", temperature factor: " << calibration.temperatureFactor() <<
+                  ", base: " << calibration.baseTemperature() << std::endl;
+    }
+
+    std::cerr << "datasets: " << datasets.size() << ", failed: " << failed << ", threads: " << threads << '\n' <<
+              "samples: " << samples << ", elapsed: " << elapsed.count() << " s, throughput: " <<
+              samples / elapsed.count() << " samples/s, " << datasets.size() / elapsed.count() << " datasets/s" <<
+              std::endl;
+
+    return failed ? 1 : 0;
+}
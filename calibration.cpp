@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include "calibration.h"
+#include "double_to_string.h"
+
+
+const std::size_t ransacIterations = 256;
+const unsigned int huberIterations = 32;
+const double significance = 3; // the temperature coefficient must exceed its standard error this many times
+
+Calibration::Calibration(const std::size_t window, const double threshold, const Method method,
+                         const double huberDelta, const double temperatureSpan, const unsigned int seed)
+{
+    m_window = window ? window : 1;
+    m_threshold = threshold;
+    m_method = method;
+    m_huberDelta = huberDelta;
+    m_temperatureSpan = temperatureSpan;
+    m_seed = seed;
+
+    m_k = 1;
+    m_b = 0;
+    m_temperatureFactor = 0;
+    m_baseTemperature = 0;
+}
+
+// Recording format: one "<temperature> <raw> <reference>" triple per line, the reference is the weight placed on
+// the scale at that moment (in output units).
+bool Calibration::load(const char *filename)
+{
+    std::ifstream inf(filename);
+
+    if (!inf.is_open())
+        return false;
+
+    Sample sample;
+
+    m_samples.clear();
+    while (inf >> sample.temperature >> sample.raw >> sample.reference)
+        m_samples.push_back(sample);
+
+    return !m_samples.empty();
+}
+
+bool Calibration::fit()
+{
+    detectPlateaus();
+
+    if (m_plateaus.size() < 2)
+        return false;
+
+    double temperatureSum = 0;
+    auto temperatureRange = std::minmax_element(m_plateaus.begin(), m_plateaus.end(),
+        [](const Plateau &l, const Plateau &r) { return l.temperature < r.temperature; });
+
+    for (const auto &el : m_plateaus)
+        temperatureSum += el.temperature;
+
+    m_baseTemperature = std::round(temperatureSum / m_plateaus.size());
+
+    // the temperature factor is only observable if the session spans a real temperature range, sensor
+    // quantization alone would otherwise be fitted as a temperature dependence
+    bool useTemperature = m_plateaus.size() > 3 &&
+        temperatureRange.second->temperature - temperatureRange.first->temperature >= m_temperatureSpan;
+    double coefficients[3] = { 1, 0, 0 };
+
+    if (!(m_method == Ransac ? fitRansac(useTemperature, coefficients) : fitHuber(useTemperature, coefficients)))
+        return false;
+
+    if (useTemperature && !temperatureSignificant(coefficients)) {
+        useTemperature = false;
+
+        if (!(m_method == Ransac ? fitRansac(useTemperature, coefficients) : fitHuber(useTemperature, coefficients)))
+            return false;
+    }
+
+    if (coefficients[0] == 0)
+        return false;
+
+    m_k = coefficients[0];
+    m_temperatureFactor = coefficients[1] / coefficients[0];
+    m_b = coefficients[2];
+
+    return true;
+}
+
+std::string Calibration::alignmentString() const
+{
+    return doubleToString(m_k) + doubleToString(m_b);
+}
+
+double Calibration::rms() const
+{
+    double sum = 0;
+    std::size_t count = 0;
+
+    for (const auto &el : m_plateaus)
+        if (el.inlier) {
+            sum += el.residual * el.residual;
+            ++count;
+        }
+
+    return count ? std::sqrt(sum / count) : 0;
+}
+
+double Calibration::maxResidual() const
+{
+    double result = 0;
+
+    for (const auto &el : m_plateaus)
+        result = std::max(result, std::fabs(el.residual));
+
+    return result;
+}
+
+std::size_t Calibration::outliers() const
+{
+    return std::count_if(m_plateaus.begin(), m_plateaus.end(), [](const Plateau &el) { return !el.inlier; });
+}
+
+// A plateau is a run of at least `window` samples with the same reference in which every window has a standard
+// deviation below the threshold. Running sums keep the window statistics O(1) per sample.
+void Calibration::detectPlateaus()
+{
+    m_plateaus.clear();
+
+    Plateau current = { 0, 0, 0, 0, 0, true };
+    double sum = 0, squares = 0;
+    std::size_t begin = 0;
+
+    auto close = [this, &current]() {
+        if (current.size >= m_window) {
+            current.temperature /= current.size;
+            current.raw /= current.size;
+            m_plateaus.push_back(current);
+        }
+
+        current = { 0, 0, 0, 0, 0, true };
+    };
+
+    for (std::size_t i = 0; i < m_samples.size(); ++i) {
+        const Sample &sample = m_samples[i];
+
+        if (i > begin && sample.reference != m_samples[i - 1].reference) {
+            close();
+            begin = i;
+            sum = squares = 0;
+        }
+
+        sum += sample.raw;
+        squares += sample.raw * sample.raw;
+
+        if (i - begin >= m_window) {
+            const double raw = m_samples[i - m_window].raw;
+
+            sum -= raw;
+            squares -= raw * raw;
+        }
+
+        const std::size_t size = std::min(i - begin + 1, m_window);
+        const double mean = sum / size;
+        const double variance = std::max(squares / size - mean * mean, 0.0);
+        const bool stable = size == m_window && std::sqrt(variance) <= m_threshold;
+
+        if (!stable) {
+            close();
+            continue;
+        }
+
+        // the window which has just become stable belongs to the plateau as a whole
+        for (std::size_t j = current.size ? i : i + 1 - m_window; j <= i; ++j) {
+            current.temperature += m_samples[j].temperature;
+            current.raw += m_samples[j].raw;
+            ++current.size;
+        }
+
+        current.reference = sample.reference;
+    }
+
+    close();
+}
+
+void Calibration::normal(const std::vector<double> &weights, const bool useTemperature, double a[3][4]) const
+{
+    for (std::size_t r = 0; r < 3; ++r)
+        for (std::size_t c = 0; c < 4; ++c)
+            a[r][c] = 0;
+
+    for (std::size_t i = 0; i < m_plateaus.size(); ++i) {
+        if (weights[i] == 0)
+            continue;
+
+        const Plateau &plateau = m_plateaus[i];
+        const double x[3] = { plateau.raw, useTemperature ? plateau.temperature - m_baseTemperature : 0, 1 };
+
+        for (std::size_t r = 0; r < 3; ++r) {
+            for (std::size_t c = 0; c < 3; ++c)
+                a[r][c] += weights[i] * x[r] * x[c];
+            a[r][3] += weights[i] * x[r] * plateau.reference;
+        }
+    }
+
+    // pins the temperature term to zero when it is not fitted
+    if (!useTemperature)
+        a[1][1] = 1;
+}
+
+bool Calibration::solve(const std::vector<double> &weights, const bool useTemperature, double *coefficients) const
+{
+    double a[3][4];
+
+    normal(weights, useTemperature, a);
+
+    for (std::size_t c = 0; c < 3; ++c) {
+        std::size_t pivot = c;
+
+        for (std::size_t r = c + 1; r < 3; ++r)
+            if (std::fabs(a[r][c]) > std::fabs(a[pivot][c]))
+                pivot = r;
+
+        if (a[pivot][c] == 0)
+            return false;
+
+        for (std::size_t k = 0; k < 4; ++k)
+            std::swap(a[c][k], a[pivot][k]);
+
+        for (std::size_t r = c + 1; r < 3; ++r) {
+            const double factor = a[r][c] / a[c][c];
+
+            for (std::size_t k = c; k < 4; ++k)
+                a[r][k] -= factor * a[c][k];
+        }
+    }
+
+    for (std::size_t c = 3; c-- > 0;) {
+        double sum = a[c][3];
+
+        for (std::size_t k = c + 1; k < 3; ++k)
+            sum -= a[c][k] * coefficients[k];
+        coefficients[c] = sum / a[c][c];
+    }
+
+    return true;
+}
+
+bool Calibration::fitHuber(const bool useTemperature, double *coefficients)
+{
+    std::vector<double> weights(m_plateaus.size(), 1);
+
+    for (unsigned int i = 0; i < huberIterations; ++i) {
+        if (!solve(weights, useTemperature, coefficients))
+            return false;
+
+        updateResiduals(useTemperature, coefficients);
+
+        bool changed = false;
+
+        for (std::size_t j = 0; j < m_plateaus.size(); ++j) {
+            const double residual = std::fabs(m_plateaus[j].residual);
+            const double weight = residual <= m_huberDelta ? 1 : m_huberDelta / residual;
+
+            changed = changed || std::fabs(weight - weights[j]) > 1e-6;
+            weights[j] = weight;
+        }
+
+        if (!changed)
+            break;
+    }
+
+    return true;
+}
+
+bool Calibration::fitRansac(const bool useTemperature, double *coefficients)
+{
+    const std::size_t minimal = useTemperature ? 3 : 2;
+    std::mt19937 generator(m_seed);
+    std::vector<std::size_t> indices(m_plateaus.size());
+    std::vector<double> weights(m_plateaus.size());
+    std::vector<double> best;
+    std::size_t bestInliers = 0;
+
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        indices[i] = i;
+
+    for (std::size_t i = 0; i < ransacIterations; ++i) {
+        double candidate[3] = { 1, 0, 0 };
+
+        // partial Fisher-Yates shuffle draws distinct plateaus
+        std::fill(weights.begin(), weights.end(), 0);
+        for (std::size_t j = 0; j < minimal; ++j) {
+            std::uniform_int_distribution<std::size_t> distribution(j, indices.size() - 1);
+
+            std::swap(indices[j], indices[distribution(generator)]);
+            weights[indices[j]] = 1;
+        }
+
+        if (!solve(weights, useTemperature, candidate))
+            continue;
+
+        updateResiduals(useTemperature, candidate);
+
+        const std::size_t inliers = m_plateaus.size() - outliers();
+
+        if (inliers > bestInliers) {
+            bestInliers = inliers;
+            best.assign(m_plateaus.size(), 0);
+
+            for (std::size_t j = 0; j < m_plateaus.size(); ++j)
+                best[j] = m_plateaus[j].inlier ? 1 : 0;
+        }
+    }
+
+    // refit on the consensus set, or on everything if no sample produced a model
+    if (best.empty())
+        best.assign(m_plateaus.size(), 1);
+
+    if (!solve(best, useTemperature, coefficients))
+        return false;
+
+    updateResiduals(useTemperature, coefficients);
+
+    return true;
+}
+
+void Calibration::updateResiduals(const bool useTemperature, const double *coefficients)
+{
+    for (auto &el : m_plateaus) {
+        const double temperature = useTemperature ? el.temperature - m_baseTemperature : 0;
+
+        el.residual = coefficients[0] * el.raw + coefficients[1] * temperature + coefficients[2] - el.reference;
+        el.inlier = std::fabs(el.residual) <= m_huberDelta;
+    }
+}
+
+// Compares the temperature coefficient with its standard error over the inliers of the current fit
+bool Calibration::temperatureSignificant(const double *coefficients) const
+{
+    std::vector<double> weights(m_plateaus.size());
+    double squares = 0, count = 0;
+
+    for (std::size_t i = 0; i < m_plateaus.size(); ++i) {
+        weights[i] = m_plateaus[i].inlier ? 1 : 0;
+        squares += weights[i] * m_plateaus[i].residual * m_plateaus[i].residual;
+        count += weights[i];
+    }
+
+    if (count <= 3)
+        return false;
+
+    double a[3][4];
+
+    normal(weights, true, a);
+
+    const double determinant = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+                               a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+                               a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+
+    if (determinant <= 0)
+        return false;
+
+    // diagonal element of the inverted normal matrix for the temperature term
+    const double inverse = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) / determinant;
+    const double variance = squares / (count - 3) * inverse;
+
+    return std::fabs(coefficients[1]) > significance * std::sqrt(std::max(variance, 0.0));
+}
@@ -0,0 +1,78 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+// Offline calibration of a single scale from a recorded session. Stable plateaus are detected in the raw stream and
+// `reference = (raw + (temperature - baseTemperature) * temperatureFactor) * k + b` is fitted to them robustly.
+class Calibration {
+public:
+    enum Method {
+        Huber = 0,
+        Ransac = 1
+    };
+
+    struct Sample {
+        double temperature;
+        double raw;
+        double reference;
+    };
+
+    struct Plateau {
+        double temperature;
+        double raw;
+        double reference;
+        std::size_t size;
+        double residual;
+        bool inlier;
+    };
+
+private:
+    std::size_t m_window;
+    double m_threshold;
+    Method m_method;
+    double m_huberDelta;
+    double m_temperatureSpan;
+    unsigned int m_seed;
+
+    std::vector<Sample> m_samples;
+    std::vector<Plateau> m_plateaus;
+
+    double m_k;
+    double m_b;
+    double m_temperatureFactor;
+    int m_baseTemperature;
+
+public:
+    Calibration(const std::size_t window, const double threshold, const Method method, const double huberDelta,
+                const double temperatureSpan, const unsigned int seed = 1);
+
+    bool load(const char *filename);
+    bool fit();
+
+    inline const std::vector<Sample> &samples() const { return m_samples; }
+    inline const std::vector<Plateau> &plateaus() const { return m_plateaus; }
+    inline double k() const { return m_k; }
+    inline double b() const { return m_b; }
+    inline double temperatureFactor() const { return m_temperatureFactor; }
+    inline int baseTemperature() const { return m_baseTemperature; }
+
+    std::string alignmentString() const;
+    double rms() const;
+    double maxResidual() const;
+    std::size_t outliers() const;
+
+protected:
+    void detectPlateaus();
+    void normal(const std::vector<double> &weights, const bool useTemperature, double a[3][4]) const;
+    bool solve(const std::vector<double> &weights, const bool useTemperature, double *coefficients) const;
+    bool fitHuber(const bool useTemperature, double *coefficients);
+    bool fitRansac(const bool useTemperature, double *coefficients);
+    void updateResiduals(const bool useTemperature, const double *coefficients);
+    bool temperatureSignificant(const double *coefficients) const;
+};
+
+#endif // CALIBRATION_H
@@ -0,0 +1,205 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "temperature_compensation.h"
+#include "string_to_double.h"
+#include "config.h"
+
+
+struct Record {
+    double temperature;
+    double raw;
+    double reference;
+};
+
+std::string help()
+{
+    return "\n\nhx711_fit <alignment_string> <interpolation> <temperatures> <loads> <data_filename> <table_filename>\n\n"
+           "\talignment string - ascii-coded 16 bytes of double k and b factors from y = k * x + b\n"
+           "\tinterpolation - 0 - bilinear, 1 - piecewise cubic (Catmull-Rom)\n"
+           "\ttemperatures - count of temperature breakpoints\n"
+           "\tloads - count of load breakpoints\n"
+           "\tdata filename - recorded samples, one \"<temperature> <raw> <reference>\" triple per line\n"
+           "\t\t(temperature in thousandths of degrees Celsius, reference in output units)\n"
+           "\ttable filename - output compensation table\n";
+}
+
+std::vector<double> breakpoints(const double min, const double max, const std::size_t count)
+{
+    std::vector<double> result(count, min);
+
+    for (std::size_t i = 1; i < count; ++i)
+        result[i] = min + (max - min) * i / (count - 1);
+
+    return result;
+}
+
+// Solves the linear system in place using Gaussian elimination with partial pivoting.
+bool solve(std::vector<double> &a, std::vector<double> &b)
+{
+    const std::size_t n = b.size();
+
+    for (std::size_t col = 0; col < n; ++col) {
+        std::size_t pivot = col;
+
+        for (std::size_t row = col + 1; row < n; ++row)
+            if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col]))
+                pivot = row;
+
+        if (a[pivot * n + col] == 0)
+            return false;
+
+        if (pivot != col) {
+            std::swap_ranges(a.begin() + col * n, a.begin() + (col + 1) * n, a.begin() + pivot * n);
+            std::swap(b[col], b[pivot]);
+        }
+
+        for (std::size_t row = col + 1; row < n; ++row) {
+            const double factor = a[row * n + col] / a[col * n + col];
+
+            if (factor == 0)
+                continue;
+
+            for (std::size_t k = col; k < n; ++k)
+                a[row * n + k] -= factor * a[col * n + k];
+            b[row] -= factor * b[col];
+        }
+    }
+
+    for (std::size_t col = n; col-- > 0;) {
+        double sum = b[col];
+
+        for (std::size_t k = col + 1; k < n; ++k)
+            sum -= a[col * n + k] * b[k];
+        b[col] = sum / a[col * n + col];
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::cerr << "HX711 compensation table fitting tool, version " << applicationVersion << '\n' << std::endl;
+
+    if (argc != 7) {
+        std::cerr << "No enough parameters" << help() << std::endl;
+        return 1;
+    }
+
+    const char *alignmentString = argv[1];
+    const auto interpolation = static_cast<TemperatureCompensation::Interpolation>(atoi(argv[2]) ? 1 : 0);
+    const int temperaturesCount = atoi(argv[3]);
+    const int loadsCount = atoi(argv[4]);
+    const char *dataFilename = argv[5];
+    const char *tableFilename = argv[6];
+    const double k = stringToDouble(alignmentString), b = stringToDouble(alignmentString + 16);
+
+    if (temperaturesCount < 1 || loadsCount < 1 || k == 0) {
+        std::cerr << "Invalid parameters" << help() << std::endl;
+        return 1;
+    }
+
+    std::ifstream inf(dataFilename);
+
+    if (!inf.is_open()) {
+        std::cerr << "Could not open data file" << std::endl;
+        return 1;
+    }
+
+    std::vector<Record> records;
+    Record record;
+
+    while (inf >> record.temperature >> record.raw >> record.reference)
+        records.push_back(record);
+
+    if (records.empty()) {
+        std::cerr << "Data file contains no records" << std::endl;
+        return 1;
+    }
+
+    auto temperatureRange = std::minmax_element(records.begin(), records.end(),
+        [](const Record &l, const Record &r) { return l.temperature < r.temperature; });
+    auto rawRange = std::minmax_element(records.begin(), records.end(),
+        [](const Record &l, const Record &r) { return l.raw < r.raw; });
+
+    const std::vector<double> temperatures = breakpoints(temperatureRange.first->temperature,
+                                                         temperatureRange.second->temperature, temperaturesCount);
+    const std::vector<double> loads = breakpoints(rawRange.first->raw, rawRange.second->raw, loadsCount);
+
+    // Every node value enters the interpolated correction linearly, so the table is a plain linear least squares
+    // problem over the tensor-product basis. The target is the raw-domain error of the plain alignment.
+    const std::size_t n = temperatures.size() * loads.size();
+    std::vector<double> normal(n * n, 0), rhs(n, 0);
+    double residualBefore = 0;
+
+    for (const auto &el : records) {
+        std::size_t ti[TemperatureCompensation::maxBasis], li[TemperatureCompensation::maxBasis];
+        double tw[TemperatureCompensation::maxBasis], lw[TemperatureCompensation::maxBasis];
+        const std::size_t tn = TemperatureCompensation::basis(temperatures, el.temperature, interpolation, ti, tw);
+        const std::size_t ln = TemperatureCompensation::basis(loads, el.raw, interpolation, li, lw);
+        const double target = (el.reference - b) / k - el.raw;
+
+        std::size_t nodes[TemperatureCompensation::maxBasis * TemperatureCompensation::maxBasis];
+        double weights[TemperatureCompensation::maxBasis * TemperatureCompensation::maxBasis];
+        std::size_t count = 0;
+
+        for (std::size_t i = 0; i < tn; ++i)
+            for (std::size_t j = 0; j < ln; ++j) {
+                nodes[count] = ti[i] * loads.size() + li[j];
+                weights[count++] = tw[i] * lw[j];
+            }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            rhs[nodes[i]] += weights[i] * target;
+
+            for (std::size_t j = 0; j < count; ++j)
+                normal[nodes[i] * n + nodes[j]] += weights[i] * weights[j];
+        }
+
+        const double error = el.raw * k + b - el.reference;
+        residualBefore += error * error;
+    }
+
+    // a weak ridge keeps the nodes which no record reaches at zero correction
+    double trace = 0;
+
+    for (std::size_t i = 0; i < n; ++i)
+        trace += normal[i * n + i];
+
+    const double ridge = trace / n * 1e-9 + 1e-12;
+
+    for (std::size_t i = 0; i < n; ++i)
+        normal[i * n + i] += ridge;
+
+    if (!solve(normal, rhs)) {
+        std::cerr << "Could not fit the table, the data is degenerate" << std::endl;
+        return 1;
+    }
+
+    TemperatureCompensation compensation(temperatures, loads, rhs, interpolation);
+    double residualAfter = 0, residualMax = 0;
+
+    for (const auto &el : records) {
+        const double error = (el.raw + compensation.correction(el.temperature, el.raw)) * k + b - el.reference;
+
+        residualAfter += error * error;
+        residualMax = std::max(residualMax, std::fabs(error));
+    }
+
+    std::cerr << "records: " << records.size() << '\n' <<
+              "table: " << temperatures.size() << " x " << loads.size() <<
+              (interpolation == TemperatureCompensation::Cubic ? " cubic" : " bilinear") << '\n' <<
+              "RMS residual:: before: " << std::sqrt(residualBefore / records.size()) <<
+              ", after: " << std::sqrt(residualAfter / records.size()) << ", max: " << residualMax << std::endl;
+
+    if (!compensation.save(tableFilename)) {
+        std::cerr << "Could not write table file" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
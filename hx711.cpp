@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <cmath>
@@ -9,6 +10,7 @@
 #include "hx711.h"
 
 const unsigned int maxFails = 20;
+const double scheduleMargin = 0.2; // seconds, covers the polling period of the main loop
 HX711 *instance = nullptr;
 
 void edge()
@@ -58,9 +60,13 @@ HX711::HX711(const int dout, const int sck, const double correctionFactor, const
              const bool useTAFilter, const int deviationFactor, const int deviationValue, const unsigned int retries,
              const bool useKalmanFilter, const double kalmanQ, const double kalmanR, const double kalmanF, const double kalmanH,
              const bool debug, const bool humanMode, const char *filename, const double temperatureFactor,
-             const int baseTemperature)
+             const int baseTemperature, const char *compensationFilename, const unsigned int stabilityWindow,
+             const double stabilityThreshold, const double zeroRange, const double zeroStep, const unsigned int notches,
+             const unsigned int spectrumWindow, const double sampleRate, const unsigned int burstInterval,
+             const unsigned int settlingFrames, const unsigned int burstFrames)
 {
     m_working = true;
+    m_burstStarted = false;
     m_k = k;
     m_b = b;
     m_correctionFactor = correctionFactor;
@@ -96,6 +102,30 @@ HX711::HX711(const int dout, const int sck, const double correctionFactor, const
     m_movingAverage = std::make_shared<MovingAverage<double, double>>(movingAverageSize);
     m_timed = std::make_shared<MovingAverage<int32_t, double>>(times);
     m_kalman = std::make_shared<SimpleKalmanFilter>(kalmanQ, kalmanR, kalmanF, kalmanH);
+
+    if (strcmp("/dev/null", compensationFilename)) {
+        m_compensation = std::make_shared<TemperatureCompensation>();
+
+        if (m_compensation->load(compensationFilename))
+            m_compensation->setAlignment(m_k, m_b);
+        else {
+            std::cerr << "Could not load compensation table, linear temperature compensation is used" << std::endl;
+            m_compensation.reset();
+        }
+    }
+
+    if (stabilityWindow)
+        m_zeroTracker = std::make_shared<ZeroTracker>(stabilityWindow, stabilityThreshold, zeroRange, zeroStep);
+
+    if (notches)
+        m_vibration = std::make_shared<VibrationFilter>(notches, spectrumWindow, sampleRate);
+
+    // a burst must be long enough to fill the filters and produce a value
+    if (burstInterval)
+        m_scheduler = std::make_shared<AcquisitionScheduler>(AcquisitionScheduler::Seconds(burstInterval),
+            settlingFrames, std::max(burstFrames, movingAverageSize + times + 1), sampleRate,
+            AcquisitionScheduler::Seconds(scheduleMargin));
+
     m_temperatureReader = std::make_shared<std::thread>(HX711::readTemperature, this, filename);
 }
 
@@ -109,11 +139,20 @@ HX711::~HX711()
     m_movingAverage.reset();
     m_timed.reset();
     m_kalman.reset();
+    m_compensation.reset();
+    m_zeroTracker.reset();
+    m_vibration.reset();
+    m_scheduler.reset();
     m_temperatureReader.reset();
 }
 
 void HX711::start()
 {
+    if (m_scheduler) {
+        powerDown();
+        m_scheduler->start(AcquisitionScheduler::Clock::now());
+    }
+
     m_once = false;
     m_reading = false;
     instance = this;
@@ -157,8 +196,39 @@ void HX711::reset()
     powerUp();
 }
 
-void HX711::push(const int32_t value)
+void HX711::push(const int32_t sample)
 {
+    AcquisitionScheduler::Frame frame = AcquisitionScheduler::Measure;
+
+    if (m_scheduler) {
+        // the filters are only touched from this thread, so they are cleared here rather than in schedule()
+        if (m_burstStarted.exchange(false)) {
+            m_movingAverage->clear();
+            m_timed->clear();
+            m_kalman->reset();
+
+            if (m_vibration)
+                m_vibration->reset();
+        }
+
+        frame = m_scheduler->frame(AcquisitionScheduler::Clock::now());
+
+        if (frame == AcquisitionScheduler::Discard)
+            return;
+    }
+
+    int32_t value = sample;
+
+    if (m_vibration) {
+        value = std::lround(m_vibration->push(sample));
+
+        if (m_debug && m_vibration->analyzed())
+            printSpectrum();
+    }
+
+    if (m_compensation)
+        m_compensation->update(m_temperature);
+
     if (m_movingAverage->size() < m_movingAverage->maxSize()) {
         if (m_useKalmanFilter) {
             m_kalman->initialized() ? m_kalman->correct(value) : m_kalman->setState(value, 0.1);
@@ -200,15 +270,37 @@ void HX711::push(const int32_t value)
             pushValue(rawValue);
     }
 
-    const int result = align(m_movingAverage->value(), true);
+    if (m_scheduler && frame != AcquisitionScheduler::Last)
+        return;
+
+    int result;
+
+    if (m_zeroTracker)
+        result = std::round(m_zeroTracker->push(align(m_movingAverage->value()) * m_correctionFactor + m_offset));
+    else
+        result = align(m_movingAverage->value(), true);
 
     if (m_humanMode) {
         for (int i = 0; i < 80; ++i)
             std::cout << '\b';
         std::cout << result << ' ' << m_temperature << ' ' << m_temperatureReadFail << ' ' << result;
+
+        if (m_zeroTracker)
+            std::cout << ' ' << (m_zeroTracker->stable() ? "stable" : "      ") << ' ' <<
+                (m_zeroTracker->motion() ? "motion" : "      ");
     }
+    else if (m_zeroTracker)
+        std::cout << result << ' ' << m_zeroTracker->stable() << ' ' << m_zeroTracker->motion() << std::endl;
     else
         std::cout << result << std::endl;
+
+    if (frame == AcquisitionScheduler::Last) {
+        powerDown();
+        m_scheduler->finish(AcquisitionScheduler::Clock::now());
+
+        if (m_debug)
+            printSchedule();
+    }
 }
 
 void HX711::incFails()
@@ -220,6 +312,35 @@ void HX711::incFails()
     }
 }
 
+void HX711::tare()
+{
+    if (m_zeroTracker)
+        m_zeroTracker->tare();
+}
+
+void HX711::schedule()
+{
+    if (!m_scheduler)
+        return;
+
+    const auto now = AcquisitionScheduler::Clock::now();
+
+    if (m_scheduler->timedOut(now)) {
+        powerDown();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_debug)
+            std::cerr << "\nBurst timed out, chip is powered down until the next wake-up" << std::endl;
+    }
+
+    if (!m_scheduler->wakeDue(now))
+        return;
+
+    // stale values must not leak into the burst, push() clears the filters on the first frame
+    m_burstStarted = true;
+    powerUp();
+}
+
 void HX711::pushValue(const double &value)
 {
     if (m_useKalmanFilter) {
@@ -253,6 +374,37 @@ bool HX711::taFilter(const double &value)
     return true;
 }
 
+void HX711::printSpectrum()
+{
+    const auto &spectrum = m_vibration->spectrum();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::cerr << "Spectrum:";
+    for (std::size_t i = 1; i < spectrum.size(); ++i)
+        std::cerr << ' ' << m_vibration->binFrequency(i) << ':' << spectrum[i];
+
+    std::cerr << "\nNotches:";
+    for (const auto &el : m_vibration->notches())
+        if (el.enabled())
+            std::cerr << ' ' << el.frequency() * m_vibration->sampleRate();
+
+    std::cerr << std::endl;
+}
+
+void HX711::printSchedule()
+{
+    const auto now = AcquisitionScheduler::Clock::now();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::cerr << "\nBurst:: latency: " << m_scheduler->lastLatency().count() << " s, max: " <<
+              m_scheduler->maxLatency().count() << " s, bursts: " << m_scheduler->bursts() << ", missed: " <<
+              m_scheduler->missed() << ", skipped: " << m_scheduler->skipped() << ", timeouts: " <<
+              m_scheduler->timeouts() << '\n' <<
+              "Power:: duty cycle: " << m_scheduler->dutyCycle(now) * 100 << " %, current: " <<
+              m_scheduler->averageCurrent(now) << " mA, energy: " << m_scheduler->energyPerResult(now) <<
+              " mJ per result" << std::endl;
+}
+
 void HX711::readTemperature(HX711 *instance, const char *filename)
 {
     std::ifstream inf;
@@ -8,6 +8,10 @@
 #include <mutex>
 #include "moving_average.h"
 #include "simple_kalman_filter.h"
+#include "temperature_compensation.h"
+#include "zero_tracker.h"
+#include "vibration_filter.h"
+#include "acquisition_scheduler.h"
 
 
 class HX711 {
@@ -20,6 +24,7 @@ class HX711 {
 
     bool m_debug;
     std::atomic_bool m_working;
+    std::atomic_bool m_burstStarted;
 
     bool m_useTAFilter;
     bool m_useKalmanFilter;
@@ -47,6 +52,10 @@ class HX711 {
     std::shared_ptr<MovingAverage<double, double>> m_movingAverage;
     std::shared_ptr<MovingAverage<int32_t, double>> m_timed;
     std::shared_ptr<SimpleKalmanFilter> m_kalman;
+    std::shared_ptr<TemperatureCompensation> m_compensation;
+    std::shared_ptr<ZeroTracker> m_zeroTracker;
+    std::shared_ptr<VibrationFilter> m_vibration;
+    std::shared_ptr<AcquisitionScheduler> m_scheduler;
     std::shared_ptr<std::thread> m_temperatureReader;
 
 public:
@@ -55,7 +64,10 @@ public:
           const bool useTAFilter, const int deviationFactor, const int deviationValue, const unsigned int retries,
           const bool useKalmanFilter, const double kalmanQ, const double kalmanR, const double kalmanF, const double kalmanH,
           const bool debug, const bool humanMode, const char *filename, const double temperatureFactor,
-          const int baseTemperature);
+          const int baseTemperature, const char *compensationFilename, const unsigned int stabilityWindow,
+          const double stabilityThreshold, const double zeroRange, const double zeroStep, const unsigned int notches,
+          const unsigned int spectrumWindow, const double sampleRate, const unsigned int burstInterval,
+          const unsigned int settlingFrames, const unsigned int burstFrames);
     virtual ~HX711();
 
     inline int dout() { return m_dout; }
@@ -75,20 +87,26 @@ public:
     void powerDown();
     void powerUp();
     void reset();
-    void push(const int32_t value);
+    void push(const int32_t sample);
     void incFails();
+    void tare();
+    void schedule();
 
 protected:
     void pushValue(const double &value);
+    void printSpectrum();
+    void printSchedule();
     bool taFilter(const double &value);
     inline double align(const double &value)
     {
+        if (m_compensation)
+            return m_compensation->apply(value);
+
         return (value + (m_temperature - m_baseTemperature) * m_temperatureFactor) * m_k + m_b;
     }
     inline int align(const double &value, const bool integer)
     {
-        return std::round(((value + (m_temperature - m_baseTemperature) * m_temperatureFactor) * m_k + m_b) *
-            m_correctionFactor + m_offset);
+        return std::round(align(value) * m_correctionFactor + m_offset);
     }
     static void readTemperature(HX711 *instance, const char *filename);
 };
@@ -11,6 +11,7 @@
 
 
 bool sigTerm = false;
+bool sigTare = false;
 
 void onTerminate(int signum, siginfo_t *info, void *ptr)
 {
@@ -18,6 +19,22 @@ void onTerminate(int signum, siginfo_t *info, void *ptr)
     sigTerm = true;
 }
 
+void onTare(int signum, siginfo_t *info, void *ptr)
+{
+    sigTare = true;
+}
+
+void catchSigusr1()
+{
+    static struct sigaction sigact;
+
+    memset(&sigact, 0, sizeof(sigact));
+    sigact.sa_sigaction = onTare;
+    sigact.sa_flags = SA_SIGINFO;
+
+    sigaction(SIGUSR1, &sigact, NULL);
+}
+
 void catchSigterm()
 {
     static struct sigaction sigact;
@@ -43,7 +60,10 @@ std::string help()
                        "\t<moving_average> <times> <dout> <sck> <deviation_factor>\n"
                        "\t<deviation_value> <retries> <use_ta_filter> <use_kalman_filter>\n"
                        "\t<kalman_q> <kalman_r> <kalman_f> <kalman_h> <temperature_filename>\n"
-                       "\t<temperature_factor> <base_temperature> <debug>\n\n") +
+                       "\t<temperature_factor> <base_temperature> <debug> [compensation_table]\n"
+                       "\t[stability_window] [stability_threshold] [zero_range] [zero_step]\n"
+                       "\t[notches] [spectrum_window] [sample_rate] [burst_interval] [settling_frames]\n"
+                       "\t[burst_frames]\n\n") +
            tb + "int" + cu + "human mode" + c + " - " + w + '0' + c + " - Normal mode, " + w + '1' + c + " - Human mode\n" +
            "\t\t(input and output all values as decimal except alignment string)\n" +
            tb + "double" + c + " (Human mode) " + b + "string" + cu + "correction factor" + c + " - correction factor, multiplies to a result value\n" +
@@ -66,7 +86,20 @@ std::string help()
            tb + "string" + cu + "temperature filename" + c + " - a name of file contains temperature value\n" +
            tb + "double" + c + " (Human mode) " + b + "string" + cu + "temperature factor" + c + " - temperature compensation\n\t\tfactor\n" +
            tb + "int" + cu + "base temperature" + c + " - reference temperature value (in thousandths of\n\t\tdegrees Celsius)\n" +
-           tb + "int" + cu + "debug" + c + " - " + w + '0' + c + " - disable debug, " + w + '1' + c + " - enable (debug messages outputs to\n\t\tstderr)\n";
+           tb + "int" + cu + "debug" + c + " - " + w + '0' + c + " - disable debug, " + w + '1' + c + " - enable (debug messages outputs to\n\t\tstderr)\n" +
+           tb + "string" + cu + "compensation table" + c + " - (optional) a name of file contains temperature x load\n\t\tcompensation table, replaces temperature factor (" + w + "/dev/null" + c + " - disable)\n" +
+           tb + "unsigned int" + cu + "stability window" + c + " - (optional) count of output values used to detect\n\t\tstability and motion, " + w + '0' + c + " - disable zero tracking\n" +
+           tb + "double" + c + " (Human mode) " + b + "string" + cu + "stability threshold" + c + " - maximal deviation and drift\n\t\tover the window of a stable value\n" +
+           tb + "double" + c + " (Human mode) " + b + "string" + cu + "zero range" + c + " - automatic zero tracking works only if a\n\t\tstable value is closer to zero\n" +
+           tb + "double" + c + " (Human mode) " + b + "string" + cu + "zero step" + c + " - maximal automatic zero correction per value\n" +
+           tb + "unsigned int" + cu + "notches" + c + " - (optional) count of adaptive notch filters placed in front of\n\t\tthe filters to remove vibrations, " + w + '0' + c + " - disable\n" +
+           tb + "unsigned int" + cu + "spectrum window" + c + " - count of raw values used for the vibration spectrum\n" +
+           tb + "double" + c + " (Human mode) " + b + "string" + cu + "sample rate" + c + " - HX711 samples per second, used to report\n\t\tthe spectrum in Hz\n" +
+           tb + "unsigned int" + cu + "burst interval" + c + " - (optional) seconds between results, the chip is powered\n\t\tdown between bursts, " + w + '0' + c + " - continuous conversion\n" +
+           tb + "unsigned int" + cu + "settling frames" + c + " - count of values discarded after the chip wakes up\n" +
+           tb + "unsigned int" + cu + "burst frames" + c + " - count of values passed through the filters per result (at\n\t\tleast moving average + times + 1)\n" +
+           "\n\tWith zero tracking every output value is followed by " + w + "stable" + c + " and " + w + "motion" + c + " flags,\n" +
+           "\t" + w + "SIGUSR1" + c + " tares the scale at the next stable value.\n";
 
 }
 
@@ -78,12 +111,13 @@ int main(int argc, char *argv[])
 
     std::cerr << welcome.str() << std::endl;
 
-    if (argc != 22) {
+    if (argc < 22 || argc > 33) {
         std::cerr << "No enough parameters" << help() << std::endl;
         return 1;
     }
 
     catchSigterm();
+    catchSigusr1();
 
     const bool humanMode = static_cast<bool>(atoi(argv[1]));
     const double correctionFactor = humanMode ? atof(argv[2]) : stringToDouble(argv[2]);
@@ -106,6 +140,17 @@ int main(int argc, char *argv[])
     const double temperatureFactor = humanMode ? atof(argv[19]) : stringToDouble(argv[19]);
     const int baseTemperature = atoi(argv[20]);
     const bool debug = static_cast<bool>(atoi(argv[21]));
+    const char *compensationFilename = argc > 22 ? argv[22] : "/dev/null";
+    const int stabilityWindow = argc > 23 ? atoi(argv[23]) : 0;
+    const double stabilityThreshold = argc > 24 ? (humanMode ? atof(argv[24]) : stringToDouble(argv[24])) : 0;
+    const double zeroRange = argc > 25 ? (humanMode ? atof(argv[25]) : stringToDouble(argv[25])) : 0;
+    const double zeroStep = argc > 26 ? (humanMode ? atof(argv[26]) : stringToDouble(argv[26])) : 0;
+    const int notches = argc > 27 ? atoi(argv[27]) : 0;
+    const int spectrumWindow = argc > 28 ? atoi(argv[28]) : 64;
+    const double sampleRate = argc > 29 ? (humanMode ? atof(argv[29]) : stringToDouble(argv[29])) : 10;
+    const int burstInterval = argc > 30 ? atoi(argv[30]) : 0;
+    const int settlingFrames = argc > 31 ? atoi(argv[31]) : 4;
+    const int burstFrames = argc > 32 ? atoi(argv[32]) : 0;
     const double k = stringToDouble(alignmentString), b = stringToDouble(alignmentString + 16);
 
     if (debug) {
@@ -124,14 +169,23 @@ int main(int argc, char *argv[])
                   "debug: " << debug << '\n' <<
                   "human mode: " << humanMode << '\n' <<
                   "temperature filename: " << temperatureFilename << '\n' <<
-                  "temperature factor: " << temperatureFactor << ", base: " << baseTemperature;
+                  "temperature factor: " << temperatureFactor << ", base: " << baseTemperature << '\n' <<
+                  "compensation table: " << compensationFilename << '\n' <<
+                  "zero tracking:: window: " << stabilityWindow << ", threshold: " << stabilityThreshold <<
+                  ", range: " << zeroRange << ", step: " << zeroStep << '\n' <<
+                  "vibration filter:: notches: " << notches << ", window: " << spectrumWindow <<
+                  ", sample rate: " << sampleRate << '\n' <<
+                  "scheduler:: interval: " << burstInterval << ", settling frames: " << settlingFrames <<
+                  ", burst frames: " << burstFrames;
 
         std::cerr << debugInfo.str() << std::endl;
     }
 
     auto hx = new HX711(dout, sck, correctionFactor, offset, movingAverage, times, k, b, useTAFilter, deviationFactor,
                         deviationValue, retries, useKalmanFilter, kalmanQ, kalmanR, kalmanF, kalmanH, debug, humanMode,
-                        temperatureFilename, temperatureFactor, baseTemperature);
+                        temperatureFilename, temperatureFactor, baseTemperature, compensationFilename,
+                        stabilityWindow, stabilityThreshold, zeroRange, zeroStep, notches, spectrumWindow, sampleRate,
+                        burstInterval, settlingFrames, burstFrames);
 
     hx->setGain(1);
     hx->read();
@@ -145,8 +199,16 @@ int main(int argc, char *argv[])
         hx->reset();
         hx->start();
 
-        while (!sigTerm)
+        while (!sigTerm) {
+            if (sigTare) {
+                sigTare = false;
+                hx->tare();
+            }
+
+            hx->schedule();
+
             usleep(100000);
+        }
     }
 
     delete hx;
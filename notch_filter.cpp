@@ -0,0 +1,47 @@
+#include <cmath>
+
+#include "notch_filter.h"
+
+
+NotchFilter::NotchFilter(const double radius)
+{
+    m_frequency = 0;
+    m_radius = radius;
+    m_enabled = false;
+
+    m_b0 = 1;
+    m_b1 = m_b2 = m_a1 = m_a2 = 0;
+    m_s1 = m_s2 = 0;
+}
+
+// `value` is the current input, it seeds the state of a newly enabled filter to avoid a start-up transient
+void NotchFilter::setFrequency(const double frequency, const double value)
+{
+    const double c = std::cos(2 * M_PI * frequency);
+    const double gain = (1 - 2 * m_radius * c + m_radius * m_radius) / (2 - 2 * c);
+
+    m_frequency = frequency;
+    m_b0 = gain;
+    m_b1 = -2 * c * gain;
+    m_b2 = gain;
+    m_a1 = -2 * m_radius * c;
+    m_a2 = m_radius * m_radius;
+
+    if (!m_enabled) {
+        m_enabled = true;
+        reset(value);
+    }
+}
+
+void NotchFilter::disable()
+{
+    m_enabled = false;
+    m_frequency = 0;
+}
+
+// Steady state of a constant input
+void NotchFilter::reset(const double value)
+{
+    m_s2 = (m_b2 - m_a2) * value;
+    m_s1 = (m_b1 - m_a1) * value + m_s2;
+}
@@ -0,0 +1,48 @@
+#ifndef NOTCH_FILTER_H
+#define NOTCH_FILTER_H
+
+
+// Second order IIR notch with zeros on the unit circle and poles at `radius`, normalized to unity gain at DC so it
+// never changes a static weight. The frequency can be retuned on the fly, the filter state is kept.
+class NotchFilter {
+    double m_frequency; // cycles per sample
+    double m_radius;
+    bool m_enabled;
+
+    double m_b0;
+    double m_b1;
+    double m_b2;
+    double m_a1;
+    double m_a2;
+
+    double m_s1;
+    double m_s2;
+
+public:
+    NotchFilter(const double radius);
+
+    inline double frequency() const { return m_frequency; }
+    inline bool enabled() const { return m_enabled; }
+
+    void setFrequency(const double frequency, const double value);
+    void disable();
+
+    inline double filter(const double value)
+    {
+        if (!m_enabled)
+            return value;
+
+        // direct form II transposed
+        const double result = m_b0 * value + m_s1;
+
+        m_s1 = m_b1 * value - m_a1 * result + m_s2;
+        m_s2 = m_b2 * value - m_a2 * result;
+
+        return result;
+    }
+
+protected:
+    void reset(const double value);
+};
+
+#endif // NOTCH_FILTER_H
@@ -21,6 +21,7 @@ public:
     inline double covariance() const { return m_covariance; }
 
     inline bool initialized() const { return m_initialized; }
+    inline void reset() { m_initialized = false; }
 
     void correct(const double data);
 };
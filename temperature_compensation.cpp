@@ -0,0 +1,246 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include "temperature_compensation.h"
+
+
+TemperatureCompensation::TemperatureCompensation(const std::size_t gridSize)
+{
+    m_interpolation = Bilinear;
+    m_k = 1;
+    m_b = 0;
+    m_gridSize = gridSize ? gridSize : 1;
+    m_gridStart = 0;
+    m_gridScale = 0;
+    m_gridTemperature = 0;
+    m_dirty = true;
+}
+
+TemperatureCompensation::TemperatureCompensation(const std::vector<double> &temperatures,
+                                                 const std::vector<double> &loads,
+                                                 const std::vector<double> &corrections,
+                                                 const Interpolation interpolation, const std::size_t gridSize)
+    : TemperatureCompensation(gridSize)
+{
+    m_interpolation = interpolation;
+    m_temperatures = temperatures;
+    m_loads = loads;
+    m_corrections = corrections;
+}
+
+/*
+ * Table file format (whitespace separated):
+ *   <interpolation: 0 - bilinear, 1 - cubic> <temperatures count> <loads count>
+ *   <temperatures in thousandths of degrees Celsius, ascending>
+ *   <loads in raw units, ascending>
+ *   <corrections in raw units, one row per temperature>
+ */
+bool TemperatureCompensation::load(const char *filename)
+{
+    std::ifstream inf(filename);
+
+    if (!inf.is_open())
+        return false;
+
+    int interpolation;
+    std::size_t temperaturesCount, loadsCount;
+
+    if (!(inf >> interpolation >> temperaturesCount >> loadsCount))
+        return false;
+
+    if ((interpolation != Bilinear && interpolation != Cubic) || !temperaturesCount || !loadsCount)
+        return false;
+
+    std::vector<double> temperatures(temperaturesCount), loads(loadsCount), corrections(temperaturesCount * loadsCount);
+
+    for (auto &el : temperatures)
+        if (!(inf >> el))
+            return false;
+
+    for (auto &el : loads)
+        if (!(inf >> el))
+            return false;
+
+    for (auto &el : corrections)
+        if (!(inf >> el))
+            return false;
+
+    if (!std::is_sorted(temperatures.begin(), temperatures.end()) || !std::is_sorted(loads.begin(), loads.end()))
+        return false;
+
+    m_interpolation = static_cast<Interpolation>(interpolation);
+    m_temperatures.swap(temperatures);
+    m_loads.swap(loads);
+    m_corrections.swap(corrections);
+    m_dirty = true;
+
+    return true;
+}
+
+bool TemperatureCompensation::save(const char *filename) const
+{
+    std::ofstream outf(filename);
+
+    if (!outf.is_open())
+        return false;
+
+    outf << std::setprecision(std::numeric_limits<double>::max_digits10);
+    outf << m_interpolation << ' ' << m_temperatures.size() << ' ' << m_loads.size() << '\n';
+
+    for (std::size_t i = 0; i < m_temperatures.size(); ++i)
+        outf << (i ? " " : "") << m_temperatures[i];
+    outf << '\n';
+
+    for (std::size_t i = 0; i < m_loads.size(); ++i)
+        outf << (i ? " " : "") << m_loads[i];
+    outf << '\n';
+
+    for (std::size_t i = 0; i < m_corrections.size(); ++i)
+        outf << m_corrections[i] << ((i + 1) % m_loads.size() ? ' ' : '\n');
+
+    return static_cast<bool>(outf);
+}
+
+void TemperatureCompensation::setAlignment(const double k, const double b)
+{
+    m_k = k;
+    m_b = b;
+    m_dirty = true;
+}
+
+double TemperatureCompensation::correction(const double temperature, const double value) const
+{
+    if (empty())
+        return 0;
+
+    std::size_t ti[maxBasis], li[maxBasis];
+    double tw[maxBasis], lw[maxBasis];
+    const std::size_t tn = basis(m_temperatures, temperature, m_interpolation, ti, tw);
+    const std::size_t ln = basis(m_loads, value, m_interpolation, li, lw);
+    double result = 0;
+
+    for (std::size_t i = 0; i < tn; ++i)
+        for (std::size_t j = 0; j < ln; ++j)
+            result += tw[i] * lw[j] * m_corrections[ti[i] * m_loads.size() + li[j]];
+
+    return result;
+}
+
+std::size_t TemperatureCompensation::basis(const std::vector<double> &axis, const double x,
+                                           const Interpolation interpolation, std::size_t *indices, double *weights)
+{
+    const std::size_t size = axis.size();
+
+    if (size < 2 || x <= axis.front()) {
+        indices[0] = 0;
+        weights[0] = 1;
+        return 1;
+    }
+
+    if (x >= axis.back()) {
+        indices[0] = size - 1;
+        weights[0] = 1;
+        return 1;
+    }
+
+    const std::size_t segment = std::upper_bound(axis.begin(), axis.end(), x) - axis.begin() - 1;
+    const double t = (x - axis[segment]) / (axis[segment + 1] - axis[segment]);
+
+    if (interpolation == Bilinear) {
+        indices[0] = segment;
+        weights[0] = 1 - t;
+        indices[1] = segment + 1;
+        weights[1] = t;
+        return 2;
+    }
+
+    // Catmull-Rom segment, the end points are duplicated at the table edges
+    const double t2 = t * t, t3 = t2 * t;
+    const double w[maxBasis] = {
+        (-t3 + 2 * t2 - t) / 2,
+        (3 * t3 - 5 * t2 + 2) / 2,
+        (-3 * t3 + 4 * t2 + t) / 2,
+        (t3 - t2) / 2
+    };
+    std::size_t count = 0;
+
+    for (std::size_t i = 0; i < maxBasis; ++i) {
+        const std::size_t index = std::min(std::max<std::size_t>(segment + i, 1) - 1, size - 1);
+
+        if (count && indices[count - 1] == index)
+            weights[count - 1] += w[i];
+        else {
+            indices[count] = index;
+            weights[count] = w[i];
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void TemperatureCompensation::rebuild(const int temperature)
+{
+    m_gridTemperature = temperature;
+    m_dirty = false;
+
+    if (empty() || m_loads.size() < 2 || m_loads.front() == m_loads.back()) {
+        const double shift = empty() ? 0 : correction(temperature, 0);
+
+        m_grid.assign(m_gridSize + 2, Cell { m_k, shift * m_k + m_b });
+        m_gridStart = 0;
+        m_gridScale = 0;
+        return;
+    }
+
+    // collapse the temperature axis once, so the grid cells only walk the load axis
+    std::size_t ti[maxBasis];
+    double tw[maxBasis];
+    const std::size_t tn = basis(m_temperatures, temperature, m_interpolation, ti, tw);
+    std::vector<double> row(m_loads.size(), 0);
+
+    for (std::size_t i = 0; i < tn; ++i)
+        for (std::size_t j = 0; j < row.size(); ++j)
+            row[j] += tw[i] * m_corrections[ti[i] * m_loads.size() + j];
+
+    const double start = m_loads.front();
+    const double step = (m_loads.back() - start) / m_gridSize;
+
+    m_grid.resize(m_gridSize + 2);
+    m_gridStart = start;
+    m_gridScale = 1 / step;
+
+    // outside the breakpoints the correction is clamped to the edge value, the same as in correction()
+    m_grid.front() = Cell { m_k, row.front() * m_k + m_b };
+    m_grid.back() = Cell { m_k, row.back() * m_k + m_b };
+
+    double x0 = start;
+    double y0 = x0 + rowCorrection(row, x0);
+
+    for (std::size_t i = 1; i <= m_gridSize; ++i) {
+        const double x1 = start + step * i;
+        const double y1 = x1 + rowCorrection(row, x1);
+        const double slope = (y1 - y0) / (x1 - x0);
+
+        m_grid[i].slope = slope * m_k;
+        m_grid[i].intercept = (y0 - slope * x0) * m_k + m_b;
+
+        x0 = x1;
+        y0 = y1;
+    }
+}
+
+double TemperatureCompensation::rowCorrection(const std::vector<double> &row, const double value) const
+{
+    std::size_t li[maxBasis];
+    double lw[maxBasis];
+    const std::size_t ln = basis(m_loads, value, m_interpolation, li, lw);
+    double result = 0;
+
+    for (std::size_t i = 0; i < ln; ++i)
+        result += lw[i] * row[li[i]];
+
+    return result;
+}
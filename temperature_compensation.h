@@ -0,0 +1,95 @@
+#ifndef TEMPERATURE_COMPENSATION_H
+#define TEMPERATURE_COMPENSATION_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+// Temperature x load calibration table. Each node holds a correction (in raw units) which is added to a raw value
+// before the `y = k * x + b` alignment. Between nodes the table is interpolated either bilinearly or with
+// Catmull-Rom cubic segments (piecewise polynomial). For the current temperature the table is baked into a dense
+// grid of linear cells with `k` and `b` folded in, so a sample costs one lookup and one FMA.
+class TemperatureCompensation {
+public:
+    enum Interpolation {
+        Bilinear = 0,
+        Cubic = 1
+    };
+
+    static const std::size_t maxBasis = 4;
+
+private:
+    struct Cell {
+        double slope;
+        double intercept;
+    };
+
+    Interpolation m_interpolation;
+    std::vector<double> m_temperatures;
+    std::vector<double> m_loads;
+    std::vector<double> m_corrections; // row-major: temperatures x loads
+
+    double m_k;
+    double m_b;
+
+    std::size_t m_gridSize;
+    std::vector<Cell> m_grid; // gridSize + 2 cells, see apply()
+    double m_gridStart;
+    double m_gridScale;
+    int m_gridTemperature;
+    bool m_dirty;
+
+public:
+    TemperatureCompensation(const std::size_t gridSize = 256);
+    TemperatureCompensation(const std::vector<double> &temperatures, const std::vector<double> &loads,
+                            const std::vector<double> &corrections, const Interpolation interpolation,
+                            const std::size_t gridSize = 256);
+
+    bool load(const char *filename);
+    bool save(const char *filename) const;
+
+    inline Interpolation interpolation() const { return m_interpolation; }
+    inline const std::vector<double> &temperatures() const { return m_temperatures; }
+    inline const std::vector<double> &loads() const { return m_loads; }
+    inline const std::vector<double> &corrections() const { return m_corrections; }
+    inline bool empty() const { return m_corrections.empty(); }
+
+    void setAlignment(const double k, const double b);
+
+    // Rebuilds the grid only when the temperature has changed since the last call.
+    inline void update(const int temperature)
+    {
+        if (m_dirty || temperature != m_gridTemperature)
+            rebuild(temperature);
+    }
+
+    // Returns `(value + correction(temperature, value)) * k + b` for the temperature of the last update().
+    inline double apply(const double &value) const
+    {
+        // the first and the last cells hold the constant edge corrections outside the load breakpoints
+        const double position = (value - m_gridStart) * m_gridScale;
+        std::size_t index = 0;
+
+        if (position >= m_gridSize)
+            index = m_gridSize + 1;
+        else if (position >= 0)
+            index = static_cast<std::size_t>(position) + 1;
+
+        const Cell &cell = m_grid[index];
+        return std::fma(cell.slope, value, cell.intercept);
+    }
+
+    // Exact (non-gridded) correction in raw units, used by the fitting tool to compute residuals.
+    double correction(const double temperature, const double value) const;
+
+    // Fills interpolation weights of `x` over `axis` and returns their count (up to maxBasis).
+    static std::size_t basis(const std::vector<double> &axis, const double x, const Interpolation interpolation,
+                             std::size_t *indices, double *weights);
+
+protected:
+    void rebuild(const int temperature);
+    double rowCorrection(const std::vector<double> &row, const double value) const;
+};
+
+#endif // TEMPERATURE_COMPENSATION_H
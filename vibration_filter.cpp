@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#include "vibration_filter.h"
+
+
+const std::size_t minWindow = 8;
+const double peakFactor = 4; // a peak must exceed the median amplitude this many times
+const unsigned int maxMisses = 4; // a load change masks the peaks for a while, so notches are not dropped at once
+
+VibrationFilter::VibrationFilter(const std::size_t notches, const std::size_t window, const double sampleRate)
+{
+    m_window = std::max(window, minWindow);
+    m_sampleRate = sampleRate > 0 ? sampleRate : 1;
+
+    m_history.assign(m_window, 0);
+    m_position = 0;
+    m_count = 0;
+
+    const std::size_t bins = m_window / 2 + 1;
+
+    m_hann.resize(m_window);
+    for (std::size_t i = 0; i < m_window; ++i)
+        m_hann[i] = 0.5 - 0.5 * std::cos(2 * M_PI * i / m_window);
+
+    m_coefficients.resize(bins);
+    for (std::size_t k = 0; k < bins; ++k)
+        m_coefficients[k] = 2 * std::cos(2 * M_PI * k / m_window);
+
+    m_s1.assign(bins, 0);
+    m_s2.assign(bins, 0);
+    m_spectrum.assign(bins, 0);
+
+    // -3 dB width of a notch is about one bin
+    m_notches.assign(notches, NotchFilter(1 - M_PI / m_window));
+    m_misses.assign(notches, 0);
+    m_analyzed = false;
+}
+
+double VibrationFilter::push(const double value)
+{
+    m_history[m_position] = value;
+    m_position = (m_position + 1) % m_window;
+    m_analyzed = false;
+
+    if (m_count < m_window)
+        ++m_count;
+
+    // half overlapped windows
+    if (m_count == m_window && m_position % (m_window / 2) == 0)
+        analyze(value);
+
+    double result = value;
+
+    for (auto &el : m_notches)
+        result = el.filter(result);
+
+    return result;
+}
+
+void VibrationFilter::reset()
+{
+    std::fill(m_history.begin(), m_history.end(), 0);
+    std::fill(m_spectrum.begin(), m_spectrum.end(), 0);
+    std::fill(m_misses.begin(), m_misses.end(), 0);
+    m_position = 0;
+    m_count = 0;
+    m_analyzed = false;
+
+    for (auto &el : m_notches)
+        el.disable();
+}
+
+void VibrationFilter::analyze(const double value)
+{
+    double mean = 0;
+
+    for (const auto &el : m_history)
+        mean += el;
+    mean /= m_window;
+
+    const std::size_t bins = m_s1.size();
+    double *s1 = m_s1.data(), *s2 = m_s2.data();
+    const double *coefficients = m_coefficients.data();
+
+    std::fill(m_s1.begin(), m_s1.end(), 0);
+    std::fill(m_s2.begin(), m_s2.end(), 0);
+
+    for (std::size_t i = 0; i < m_window; ++i) {
+        const double x = (m_history[(m_position + i) % m_window] - mean) * m_hann[i];
+
+        for (std::size_t k = 0; k < bins; ++k) {
+            const double s0 = x + coefficients[k] * s1[k] - s2[k];
+
+            s2[k] = s1[k];
+            s1[k] = s0;
+        }
+    }
+
+    // the coherent gain of the Hann window is 1/2
+    const double scale = 4.0 / m_window;
+
+    for (std::size_t k = 0; k < bins; ++k) {
+        const double power = s1[k] * s1[k] + s2[k] * s2[k] - coefficients[k] * s1[k] * s2[k];
+
+        m_spectrum[k] = std::sqrt(std::max(power, 0.0)) * scale;
+    }
+
+    detect(value);
+    m_analyzed = true;
+}
+
+void VibrationFilter::detect(const double value)
+{
+    const std::size_t bins = m_spectrum.size();
+    std::vector<double> sorted(m_spectrum.begin() + 1, m_spectrum.end());
+
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+
+    const double threshold = sorted[sorted.size() / 2] * peakFactor;
+    std::vector<std::pair<double, double>> peaks; // amplitude, frequency in cycles per sample
+
+    // the lowest bins hold the load changes themselves, so they are never notched
+    for (std::size_t k = 2; k + 1 < bins; ++k) {
+        const double left = m_spectrum[k - 1], center = m_spectrum[k], right = m_spectrum[k + 1];
+
+        if (center <= threshold || center < left || center <= right)
+            continue;
+
+        const double curvature = left - 2 * center + right;
+        const double offset = curvature < 0 ? 0.5 * (left - right) / curvature : 0;
+
+        peaks.emplace_back(center, (k + offset) / m_window);
+    }
+
+    std::sort(peaks.begin(), peaks.end(), std::greater<std::pair<double, double>>());
+
+    if (peaks.size() > m_notches.size())
+        peaks.resize(m_notches.size());
+
+    std::vector<bool> matched(m_notches.size(), false);
+
+    // the strongest peaks are served first, each one retunes the nearest notch within two bins or takes a free one
+    for (const auto &peak : peaks) {
+        std::size_t target = m_notches.size();
+        double distance = 2.0 / m_window;
+
+        for (std::size_t i = 0; i < m_notches.size(); ++i) {
+            const double d = std::fabs(m_notches[i].frequency() - peak.second);
+
+            if (!matched[i] && m_notches[i].enabled() && d <= distance) {
+                target = i;
+                distance = d;
+            }
+        }
+
+        for (std::size_t i = 0; target == m_notches.size() && i < m_notches.size(); ++i)
+            if (!m_notches[i].enabled())
+                target = i;
+
+        // all notches are busy, the stalest one is moved
+        for (std::size_t i = 0; target == m_notches.size() && i < m_notches.size(); ++i)
+            if (!matched[i] && m_misses[i] >= maxMisses)
+                target = i;
+
+        if (target == m_notches.size())
+            continue;
+
+        m_notches[target].setFrequency(peak.second, value);
+        m_misses[target] = 0;
+        matched[target] = true;
+    }
+
+    for (std::size_t i = 0; i < m_notches.size(); ++i)
+        if (!matched[i] && m_notches[i].enabled() && ++m_misses[i] > maxMisses)
+            m_notches[i].disable();
+}
@@ -0,0 +1,54 @@
+#ifndef VIBRATION_FILTER_H
+#define VIBRATION_FILTER_H
+
+#include <cstddef>
+#include <vector>
+#include "notch_filter.h"
+
+
+// Streaming spectral analysis of the raw samples: a Goertzel bank runs over a Hann window every half a window, the
+// dominant periodic components are removed by a cascade of adaptive notch filters placed in front of the rest of the
+// filters. The bank keeps its states as separate arrays, so the per sample step is a plain loop over all bins the
+// compiler can vectorize.
+class VibrationFilter {
+    std::size_t m_window;
+    double m_sampleRate;
+
+    std::vector<double> m_history;
+    std::size_t m_position;
+    std::size_t m_count;
+
+    std::vector<double> m_hann;
+    std::vector<double> m_coefficients; // 2 * cos(2 * pi * bin / window)
+    std::vector<double> m_s1;
+    std::vector<double> m_s2;
+    std::vector<double> m_spectrum;
+
+    std::vector<NotchFilter> m_notches;
+    std::vector<unsigned int> m_misses; // analyses since the notch last matched a peak
+    bool m_analyzed;
+
+public:
+    VibrationFilter(const std::size_t notches, const std::size_t window, const double sampleRate);
+
+    // Takes the next raw sample and returns it with the detected vibrations removed.
+    double push(const double value);
+
+    // Forgets the history, the spectrum and the notches, e.g. when the chip has been powered down for a while.
+    void reset();
+
+    // True if the spectrum has been analyzed and the notches retuned at the last push().
+    inline bool analyzed() const { return m_analyzed; }
+
+    // Amplitudes (raw units) of bins 0 .. window / 2, valid after analyzed() has been true once.
+    inline const std::vector<double> &spectrum() const { return m_spectrum; }
+    inline double binFrequency(const std::size_t bin) const { return bin * m_sampleRate / m_window; }
+    inline const std::vector<NotchFilter> &notches() const { return m_notches; }
+    inline double sampleRate() const { return m_sampleRate; }
+
+protected:
+    void analyze(const double value);
+    void detect(const double value);
+};
+
+#endif // VIBRATION_FILTER_H
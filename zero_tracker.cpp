@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+
+#include "zero_tracker.h"
+
+
+ZeroTracker::ZeroTracker(const std::size_t window, const double threshold, const double zeroRange,
+                         const double zeroStep)
+{
+    m_window = window > 1 ? window : 2;
+    m_threshold = threshold;
+    m_zeroRange = zeroRange;
+    m_zeroStep = zeroStep;
+
+    m_values.assign(m_window, 0);
+    m_position = 0;
+    m_size = 0;
+
+    m_sum = m_squares = m_weighted = 0;
+
+    m_zero = 0;
+    m_stable = false;
+    m_motion = false;
+    m_tareRequested = false;
+}
+
+double ZeroTracker::mean() const
+{
+    return m_size ? m_sum / m_size : 0;
+}
+
+double ZeroTracker::deviation() const
+{
+    if (!m_size)
+        return 0;
+
+    const double average = m_sum / m_size;
+    return std::sqrt(std::max(m_squares / m_size - average * average, 0.0));
+}
+
+// Least squares slope per sample over x = 0 .. size - 1
+double ZeroTracker::slope() const
+{
+    if (m_size < 2)
+        return 0;
+
+    const double n = m_size;
+    const double sx = n * (n - 1) / 2;
+    const double sxx = (n - 1) * n * (2 * n - 1) / 6;
+
+    return (n * m_weighted - sx * m_sum) / (n * sxx - sx * sx);
+}
+
+double ZeroTracker::push(const double value)
+{
+    if (m_size < m_window) {
+        m_weighted += m_size * value;
+        m_sum += value;
+        m_squares += value * value;
+        m_values[m_position] = value;
+        ++m_size;
+    }
+    else {
+        const double oldest = m_values[m_position];
+
+        // every remaining value moves one index down
+        m_weighted += (m_size - 1) * value - (m_sum - oldest);
+        m_sum += value - oldest;
+        m_squares += value * value - oldest * oldest;
+        m_values[m_position] = value;
+    }
+
+    m_position = (m_position + 1) % m_window;
+
+    // running sums drift, so they are rebuilt once per window
+    if (!m_position)
+        recalculate();
+
+    const bool full = m_size == m_window;
+
+    m_motion = full && std::fabs(slope()) * (m_window - 1) > m_threshold;
+    m_stable = full && !m_motion && deviation() <= m_threshold;
+
+    if (m_stable) {
+        const double average = mean();
+
+        if (m_tareRequested.exchange(false))
+            m_zero = average;
+        else if (std::fabs(average - m_zero) <= m_zeroRange)
+            m_zero += std::min(std::max(average - m_zero, -m_zeroStep), m_zeroStep);
+    }
+
+    return value - m_zero;
+}
+
+void ZeroTracker::recalculate()
+{
+    m_sum = m_squares = m_weighted = 0;
+
+    for (std::size_t i = 0; i < m_size; ++i) {
+        const double value = m_values[(m_position + i) % m_size];
+
+        m_weighted += i * value;
+        m_sum += value;
+        m_squares += value * value;
+    }
+}
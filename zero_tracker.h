@@ -0,0 +1,51 @@
+#ifndef ZERO_TRACKER_H
+#define ZERO_TRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+
+// Stability detection and automatic zero tracking over the filtered output signal. Rolling mean, variance and
+// least squares slope of the last `window` values are kept in O(1) per sample.
+class ZeroTracker {
+    std::size_t m_window;
+    double m_threshold;
+    double m_zeroRange;
+    double m_zeroStep;
+
+    std::vector<double> m_values;
+    std::size_t m_position;
+    std::size_t m_size;
+
+    double m_sum;
+    double m_squares;
+    double m_weighted; // sum of index * value, indices are counted from the oldest value
+
+    double m_zero;
+    bool m_stable;
+    bool m_motion;
+    std::atomic_bool m_tareRequested;
+
+public:
+    ZeroTracker(const std::size_t window, const double threshold, const double zeroRange, const double zeroStep);
+
+    inline bool stable() const { return m_stable; }
+    inline bool motion() const { return m_motion; }
+    inline double zero() const { return m_zero; }
+
+    double mean() const;
+    double deviation() const;
+    double slope() const;
+
+    // Takes the next value and returns it relative to the tracked zero.
+    double push(const double value);
+
+    // Zeroes the scale at the next stable value. Safe to call from any thread.
+    inline void tare() { m_tareRequested = true; }
+
+protected:
+    void recalculate();
+};
+
+#endif // ZERO_TRACKER_H